@@ -0,0 +1,292 @@
+#include "main.hpp"
+#include "abnode.hpp"
+#include "stats.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+struct Corpus {
+  std::string name;
+  std::string source;
+};
+
+struct Result {
+  std::string name;
+  std::size_t bytes;
+  std::size_t tokens;
+  std::size_t statements;
+  std::size_t nodes;
+  std::size_t iterations;
+  double seconds;
+  double allocations;
+  double mbPerSecond() const { return bytes * iterations / seconds / 1e6; }
+  double tokensPerSecond() const { return tokens * iterations / seconds; }
+  double statementsPerSecond() const { return statements * iterations / seconds; }
+  double nodesPerSecond() const { return nodes * iterations / seconds; }
+};
+
+const std::size_t corpusSize = 32 * 1024;
+
+Corpus longStrings() {
+  std::string source;
+  for (int i = 0; source.size() < corpusSize; i++) {
+    source += "var s" + std::to_string(i) + " = \"";
+    for (int j = 0; j < 1000; j++) source += j % 50 == 49 ? "\\n" : "x";
+    source += "\";\n";
+  }
+  return { "long_strings", source };
+}
+
+Corpus deepNesting() {
+  std::string source;
+  for (int i = 0; source.size() < corpusSize; i++) {
+    source += "var d" + std::to_string(i) + " = ";
+    for (int j = 0; j < 200; j++) source += "(";
+    source += "1";
+    for (int j = 0; j < 200; j++) source += ")";
+    source += ";\n";
+    for (int j = 0; j < 50; j++) source += "if d" + std::to_string(i) + ": {\n";
+    source += "d" + std::to_string(i) + " += 1;\n";
+    for (int j = 0; j < 50; j++) source += "}\n";
+  }
+  return { "deep_nesting", source };
+}
+
+Corpus operatorDense() {
+  std::string source;
+  for (int i = 0; source.size() < corpusSize; i++) {
+    source += "var a" + std::to_string(i) + " = 1";
+    for (int j = 0; j < 40; j++) {
+      source += j % 5 == 0 ? " + " : j % 5 == 1 ? " * " : j % 5 == 2 ? " - " : j % 5 == 3 ? " / " : " ** ";
+      source += j % 2 ? "x" + std::to_string(j) : std::to_string(j) + ".5";
+    }
+    source += ";\n";
+  }
+  return { "operator_dense", source };
+}
+
+Corpus wideObjects() {
+  std::string source;
+  for (int i = 0; source.size() < corpusSize; i++) {
+    source += "var o" + std::to_string(i) + " = {";
+    for (int j = 0; j < 500; j++) {
+      if (j) source += ",";
+      source += " k" + std::to_string(j) + ": " + (j % 2 ? "\"v\"" : std::to_string(j));
+    }
+    source += " };\n";
+  }
+  return { "wide_objects", source };
+}
+
+Corpus smallFunctions() {
+  std::string source;
+  for (int i = 0; source.size() < corpusSize; i++) {
+    source += "fn f" + std::to_string(i) + "(a, b) {\n";
+    source += "  if a < b: return a + b;\n";
+    source += "  return f" + std::to_string(i ? i - 1 : 0) + "(b, a) * 2;\n";
+    source += "}\n";
+  }
+  return { "small_functions", source };
+}
+
+// ru_maxrss is a high-water mark for the whole process, so it is reported
+// once for the run rather than per benchmark.
+long peakRssKb() {
+#ifndef _WIN32
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+#else
+  return 0;
+#endif
+}
+
+double now() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Runs `step` until at least `minSeconds` have elapsed (and at least three
+// times), excluding whatever `setup` does before each iteration.
+template <class Setup, class Step>
+Result measure(const std::string &name, const Corpus &corpus, double minSeconds, Setup setup, Step step) {
+  Result result = { name, corpus.source.size(), 0, 0, 0, 0, 0, 0 };
+  std::uint64_t allocated = 0;
+  while (result.iterations < 3 || result.seconds < minSeconds) {
+    setup();
+    std::uint64_t before = allocationCount();
+    double start = now();
+    step(result);
+    result.seconds += now() - start;
+    allocated += allocationCount() - before;
+    result.iterations++;
+  }
+  result.allocations = static_cast<double>(allocated) / result.iterations;
+  return result;
+}
+
+Result benchLexer(const Corpus &corpus, double minSeconds) {
+  std::vector<Token> tokens;
+  return measure("lex/" + corpus.name, corpus, minSeconds, [&] {
+    tokens.clear();
+    tokens.shrink_to_fit();
+  }, [&](Result &result) {
+    parse(corpus.source.c_str(), tokens, "bench.ms");
+    result.tokens = tokens.size();
+  });
+}
+
+// Each iteration's tree goes into an arena that is freed during the next
+// setup, outside the timed region.
+Result benchParser(const Corpus &corpus, double minSeconds) {
+  std::vector<Token> tokens;
+  std::vector<StatememtNode*> statements;
+  std::unique_ptr<NodeArena> arena;
+  parse(corpus.source.c_str(), tokens, "bench.ms");
+  Result result = measure("parse/" + corpus.name, corpus, minSeconds, [&] {
+    statements.clear();
+    arena.reset(new NodeArena());
+  }, [&](Result &result) {
+    ArenaScope scope(*arena);
+    TokenCursor cursor(tokens);
+    result.tokens = tokens.size();
+    while (cursor.size()) statements.push_back(parseStatement(cursor));
+  });
+  result.statements = statements.size();
+  for (auto statement : statements) result.nodes += countNodes(statement);
+  return result;
+}
+
+std::string toJson(const std::vector<Result> &results) {
+  std::ostringstream out;
+  out << "{\"peak_rss_kb\": " << peakRssKb() << ", \"results\": [\n";
+  for (std::size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    out << "  {\"name\": \"" << r.name << "\", \"bytes\": " << r.bytes << ", \"tokens\": " << r.tokens
+        << ", \"statements\": " << r.statements << ", \"nodes\": " << r.nodes << ", \"iterations\": " << r.iterations
+        << ", \"seconds\": " << r.seconds << ", \"mb_per_s\": " << r.mbPerSecond()
+        << ", \"tokens_per_s\": " << r.tokensPerSecond() << ", \"statements_per_s\": " << r.statementsPerSecond()
+        << ", \"nodes_per_s\": " << r.nodesPerSecond()
+        << ", \"allocations\": " << r.allocations << "}"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "]}\n";
+  return out.str();
+}
+
+void printTable(const std::vector<Result> &results) {
+  for (auto &r : results) {
+    std::cout << r.name << ": " << r.mbPerSecond() << " MB/s, " << r.tokensPerSecond() << " tokens/s";
+    if (r.statements) std::cout << ", " << r.statementsPerSecond() << " statements/s, " << r.nodesPerSecond() << " nodes/s";
+    std::cout << ", " << r.allocations << " allocs/iter\n";
+  }
+  std::cout << "peak RSS (whole run): " << peakRssKb() << " KB\n";
+}
+
+struct Baseline {
+  double mbPerSecond;
+  double allocations;
+};
+
+// Reads back the "name", "mb_per_s" and "allocations" fields of a file written
+// with --json, and its "peak_rss_kb". Fields missing from older files read
+// as -1 and are not compared.
+std::map<std::string, Baseline> readBaseline(const char *filename, long &peakRss) {
+  std::map<std::string, Baseline> baseline;
+  std::ifstream in(filename);
+  if (!in) {
+    std::cerr << "Cannot open baseline: " << filename << "\n";
+    exit(1);
+  }
+  peakRss = -1;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::size_t rss = line.find("\"peak_rss_kb\": ");
+    if (rss != std::string::npos) peakRss = std::stol(line.substr(rss + 15));
+    std::size_t name = line.find("\"name\": \"");
+    std::size_t speed = line.find("\"mb_per_s\": ");
+    std::size_t allocations = line.find("\"allocations\": ");
+    if (name == std::string::npos || speed == std::string::npos) continue;
+    name += 9;
+    baseline[line.substr(name, line.find('"', name) - name)] = {
+      std::stod(line.substr(speed + 12)),
+      allocations == std::string::npos ? -1 : std::stod(line.substr(allocations + 15))
+    };
+  }
+  return baseline;
+}
+
+// Throughput regresses when it drops by more than `threshold` percent, and so
+// does peak RSS when it grows by that much. Allocation counts are
+// deterministic, so any increase over the baseline is a regression. The
+// report goes to `out`, which is stderr when stdout carries --json.
+int compare(const std::vector<Result> &results, const char *filename, double threshold, std::ostream &out) {
+  long baselineRss;
+  std::map<std::string, Baseline> baseline = readBaseline(filename, baselineRss);
+  int regressions = 0;
+  for (auto &r : results) {
+    auto it = baseline.find(r.name);
+    if (it == baseline.end()) continue;
+    double change = (r.mbPerSecond() - it->second.mbPerSecond) / it->second.mbPerSecond * 100;
+    bool regressed = change < -threshold;
+    bool allocated = it->second.allocations >= 0 && r.allocations > it->second.allocations + 0.5;
+    if (regressed || allocated) regressions++;
+    out << (regressed || allocated ? "REGRESSION " : "ok         ") << r.name << ": " << it->second.mbPerSecond << " -> "
+        << r.mbPerSecond() << " MB/s (" << (change >= 0 ? "+" : "") << change << "%)";
+    if (it->second.allocations >= 0) out << ", " << it->second.allocations << " -> " << r.allocations << " allocs/iter";
+    out << "\n";
+  }
+  if (baselineRss > 0) {
+    long rss = peakRssKb();
+    double change = static_cast<double>(rss - baselineRss) / baselineRss * 100;
+    bool regressed = change > threshold;
+    if (regressed) regressions++;
+    out << (regressed ? "REGRESSION " : "ok         ") << "peak RSS: " << baselineRss << " -> " << rss << " KB ("
+        << (change >= 0 ? "+" : "") << change << "%)\n";
+  }
+  return regressions ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  bool json = false;
+  const char *baseline = nullptr;
+  double threshold = 10, minSeconds = 0.5;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool valid = true;
+    try {
+      if (arg == "--json") {
+        json = true;
+      } else if (arg == "--compare" && i + 1 < argc) {
+        baseline = argv[++i];
+      } else if (arg == "--threshold" && i + 1 < argc) {
+        threshold = std::stod(argv[++i]);
+      } else if (arg == "--time" && i + 1 < argc) {
+        minSeconds = std::stod(argv[++i]);
+      } else {
+        valid = false;
+      }
+    } catch (const std::logic_error &) {
+      valid = false;
+    }
+    if (!valid) {
+      std::cerr << "Usage: " << argv[0] << " [--json] [--compare baseline.json] [--threshold percent] [--time seconds]\n";
+      return 1;
+    }
+  }
+  std::vector<Corpus> corpora = { longStrings(), deepNesting(), operatorDense(), wideObjects(), smallFunctions() };
+  std::vector<Result> results;
+  for (auto &corpus : corpora) results.push_back(benchLexer(corpus, minSeconds));
+  for (auto &corpus : corpora) results.push_back(benchParser(corpus, minSeconds));
+  if (json) std::cout << toJson(results);
+  else printTable(results);
+  if (baseline) return compare(results, baseline, threshold, json ? std::cerr : std::cout);
+  return 0;
+}
@@ -1,9 +1,31 @@
 #ifndef __ABNODE_H__
 #define __ABNODE_H__
 
-struct ExpressionNode {};
-struct StatememtNode {};
+struct Node {
+  Node();
+  virtual ~Node() {}
+};
 
-StatememtNode *parseStatement(std::vector<Token> &tokens);
+struct ExpressionNode : Node {};
+struct StatememtNode : Node {};
+
+// Owns every node constructed on this thread while an ArenaScope for it is
+// active, so a tree can be freed at once even though compound assignments
+// share subtrees and a syntax error can leave it half built.
+struct NodeArena {
+  std::vector<Node*> nodes;
+  NodeArena() {}
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+  ~NodeArena();
+};
+
+struct ArenaScope {
+  NodeArena *previous;
+  ArenaScope(NodeArena &arena);
+  ~ArenaScope();
+};
+
+StatememtNode *parseStatement(TokenCursor &tokens);
 
 #endif /* __ABNODE_H__ */
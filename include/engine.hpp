@@ -0,0 +1,47 @@
+#ifndef __ENGINE_H__
+#define __ENGINE_H__
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "main.hpp"
+#include "abnode.hpp"
+#include "stats.hpp"
+
+// A compiled script. It is never modified after compile() returns, so one
+// handle can be shared read-only between threads and engines.
+struct Script {
+  std::string file;
+  std::vector<StatememtNode*> statements;
+  NodeArena arena;
+};
+
+struct CompileResult {
+  std::shared_ptr<const Script> script;
+  std::string error;
+};
+
+struct CacheEntry {
+  std::shared_ptr<const Script> script;
+  std::list<const std::string*>::iterator order;
+};
+
+// Entry point for embedding hosts. An engine shares no mutable state with
+// other engines, so each worker thread can own one and compile without locks.
+// Errors in the source are returned in CompileResult::error. `stats` is
+// cleared at the start of every call, so it only ever describes one script.
+//
+// Compiled scripts are cached by file name and source only when
+// cacheCapacity is non-zero; once it is full the least recently used script
+// is dropped. A cache hit does no lexing or parsing, so it records no tokens
+// and no phases.
+struct Engine {
+  std::size_t cacheCapacity = 0;
+  std::unordered_map<std::string, CacheEntry> cache;
+  std::list<const std::string*> cacheOrder;
+  CompileResult compile(const std::string &source, const std::string &file, ScriptStats *stats = nullptr);
+  void clearCache();
+};
+
+#endif /* __ENGINE_H__ */
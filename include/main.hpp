@@ -2,6 +2,7 @@
 #define __MAIN_H__
 
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
 enum class TokenKind {
@@ -22,6 +23,26 @@ struct Token {
     : value(value), line(line), column(column), kind(kind), file(file) {}
 };
 
+// Read position in a lexed token vector. The parser consumes tokens by
+// advancing it; erasing from the front of the vector made parsing quadratic.
+struct TokenCursor {
+  std::vector<Token> &tokens;
+  std::size_t position;
+  int depth;
+  TokenCursor(std::vector<Token> &tokens) : tokens(tokens), position(0), depth(0) {}
+  Token &operator[](std::size_t index) { return tokens[position + index]; }
+  std::size_t size() const { return tokens.size() - position; }
+  void next() { position++; }
+};
+
+// Thrown by the lexer and the parser instead of terminating the process, so
+// an embedding host can report a bad script and keep running.
+struct ScriptError : std::runtime_error {
+  ScriptError(const std::string &message) : std::runtime_error(message) {}
+};
+
+std::string sourceLocation(const std::string &file, std::uint32_t line, std::uint32_t column);
+std::string sourceLocation(const Token &token);
 void parse(const char *source, std::vector<Token> &tokens, const char *filename);
 
 #endif /* __MAIN_H__ */
@@ -123,6 +123,20 @@ struct ObjectLiteralNode : ExpressionNode {
   ObjectLiteralNode(std::map<std::string, ExpressionNode*> members) : members(members) {}
 };
 
+struct ArrayLiteralNode : ExpressionNode {
+  std::vector<ExpressionNode*> elements;
+  ArrayLiteralNode(std::vector<ExpressionNode*> elements) : elements(elements) {}
+};
+
+// `float64 [...]`: an array whose elements are all numbers and can be kept
+// contiguously as doubles once scripts run. The parser rejects string, object
+// and array literal elements; computed elements can only be checked at run
+// time.
+struct Float64ArrayNode : ExpressionNode {
+  std::vector<ExpressionNode*> elements;
+  Float64ArrayNode(std::vector<ExpressionNode*> elements) : elements(elements) {}
+};
+
 struct WhileNode : StatememtNode {
   ExpressionNode *condition;
   StatememtNode* body;
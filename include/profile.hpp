@@ -0,0 +1,50 @@
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <csignal>
+#include <string>
+
+// State read by the sampling profiler's signal handler. Nothing executes
+// scripts yet, so the frames are the compile phase and the fn declarations
+// being parsed, and samples measure parse time, not run time. The parser keeps
+// the state up to date whether or not a profile is being taken; each update is
+// a store or two, so leaving the hooks in costs nothing measurable. It is per
+// thread, and a sample records whichever thread the signal interrupted.
+const int maxProfileDepth = 64;
+extern thread_local const char *profileFrames[maxProfileDepth];
+extern thread_local volatile std::sig_atomic_t profileDepth;
+extern thread_local volatile std::sig_atomic_t profileLine;
+
+inline void profileEnter(const char *name) {
+  if (profileDepth < maxProfileDepth) profileFrames[profileDepth] = name;
+  // The handler must not see the new depth before the frame it covers.
+  std::atomic_signal_fence(std::memory_order_release);
+  profileDepth = profileDepth + 1;
+}
+
+inline void profileLeave() {
+  profileDepth = profileDepth - 1;
+}
+
+// Keeps the frame stack balanced when parsing stops with a ScriptError, and
+// puts back the line that was current outside the frame, so samples taken
+// after parsing are not attributed to the last line parsed.
+struct ProfileFrame {
+  std::sig_atomic_t line;
+  ProfileFrame(const char *name) : line(profileLine) { profileEnter(name); }
+  ~ProfileFrame() {
+    profileLine = line;
+    profileLeave();
+  }
+};
+
+inline void profileAt(std::uint32_t line) {
+  profileLine = line;
+}
+
+bool startProfiler(int hz);
+std::string stopProfiler(const std::string &root);
+
+#endif /* __PROFILE_H__ */
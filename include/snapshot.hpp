@@ -0,0 +1,17 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <istream>
+#include <ostream>
+#include "engine.hpp"
+
+// A snapshot is a compiled script in a position-independent binary form:
+// nodes refer to each other by index, so loading it only allocates the nodes
+// and skips lexing and parsing entirely. Numbers are stored in the host's
+// byte order, so snapshots are only portable between machines of the same
+// endianness. writeSnapshot returns an error message, or an empty string on
+// success.
+std::string writeSnapshot(const Script &script, std::ostream &out);
+CompileResult readSnapshot(std::istream &in);
+
+#endif /* __SNAPSHOT_H__ */
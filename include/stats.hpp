@@ -0,0 +1,60 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "main.hpp"
+#include "abnode.hpp"
+
+struct PhaseStats {
+  std::string name;
+  double seconds;
+  std::uint64_t allocations;
+  std::uint64_t allocatedBytes;
+  std::map<std::string, std::uint64_t> counters;
+};
+
+struct ScriptStats {
+  std::string file;
+  std::uint64_t bytes = 0;
+  std::uint64_t tokens = 0;
+  std::uint64_t statements = 0;
+  std::uint64_t nodes = 0;
+  bool hardwareCounters = false;
+  // Set when hardwareCounters was requested but no counter could be opened,
+  // e.g. without perf_event_open permission or off Linux.
+  bool hardwareCountersUnavailable = false;
+  std::vector<PhaseStats> phases;
+  // Resets every figure but keeps the hardwareCounters setting, so one
+  // record can be reused for several scripts.
+  void clear();
+  // Fills in file, statements and nodes from a compiled script.
+  void describe(const std::string &file, const std::vector<StatememtNode*> &statements);
+  std::string toJson() const;
+};
+
+struct HardwareCounters;
+
+// Records one phase into `stats` from construction to destruction. Does
+// nothing when `stats` is null, so call sites can keep it unconditionally.
+struct PhaseRecorder {
+  ScriptStats *stats;
+  PhaseStats phase;
+  double start;
+  HardwareCounters *hardware;
+  PhaseRecorder(ScriptStats *stats, const char *name);
+  ~PhaseRecorder();
+};
+
+// The library never replaces the global allocator. Allocation counts stay at
+// zero unless the program links src/allocator.cpp (as the driver and the
+// benchmark do) or its own allocator calls recordAllocation.
+void recordAllocation(std::size_t size);
+std::uint64_t allocationCount();
+std::uint64_t allocatedBytes();
+std::uint64_t countNodes(StatememtNode *node);
+std::uint64_t countNodes(ExpressionNode *node);
+
+#endif /* __STATS_H__ */
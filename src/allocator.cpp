@@ -0,0 +1,20 @@
+#include "stats.hpp"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocator so the stats can count allocations. Only the
+// driver and the benchmark link this file; it is not part of the library.
+
+void *operator new(std::size_t size) {
+  recordAllocation(size);
+  if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
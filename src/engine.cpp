@@ -0,0 +1,56 @@
+#include "engine.hpp"
+#include "profile.hpp"
+
+CompileResult Engine::compile(const std::string &source, const std::string &file, ScriptStats *stats) {
+  if (stats) stats->clear();
+  std::string key;
+  if (cacheCapacity) {
+    key = file + '\0' + source;
+    auto cached = cache.find(key);
+    if (cached != cache.end()) {
+      cacheOrder.splice(cacheOrder.begin(), cacheOrder, cached->second.order);
+      if (stats) {
+        stats->bytes = source.size();
+        stats->describe(file, cached->second.script->statements);
+      }
+      return { cached->second.script, "" };
+    }
+  }
+  auto script = std::make_shared<Script>();
+  script->file = file;
+  std::vector<Token> tokens;
+  try {
+    {
+      PhaseRecorder phase(stats, "lex");
+      ProfileFrame frame("lex");
+      parse(source.c_str(), tokens, file.c_str());
+    }
+    if (stats) stats->tokens = tokens.size();
+    ArenaScope scope(script->arena);
+    PhaseRecorder phase(stats, "parse");
+    ProfileFrame frame("parse");
+    TokenCursor cursor(tokens);
+    while (cursor.size()) script->statements.push_back(parseStatement(cursor));
+  } catch (const ScriptError &error) {
+    return { nullptr, error.what() };
+  }
+  if (stats) {
+    stats->bytes = source.size();
+    stats->describe(file, script->statements);
+  }
+  if (cacheCapacity) {
+    if (cache.size() >= cacheCapacity) {
+      cache.erase(*cacheOrder.back());
+      cacheOrder.pop_back();
+    }
+    auto inserted = cache.emplace(std::move(key), CacheEntry { script, cacheOrder.end() }).first;
+    cacheOrder.push_front(&inserted->first);
+    inserted->second.order = cacheOrder.begin();
+  }
+  return { script, "" };
+}
+
+void Engine::clearCache() {
+  cache.clear();
+  cacheOrder.clear();
+}
@@ -1,15 +1,23 @@
 #include "main.hpp"
+#include <cstring>
 #include <set>
 
-std::string numChars = "0123456789";
-std::string oneCharSymbols = "+-*/%(){}[].<>=!?,.:;";
-std::set<std::string> reserved = {
-  "var", "while", "if", "else", "break", "continue", "return", "fn", "typeof", "keys", "empty"
+static const std::string oneCharSymbols = "+-*/%(){}[].<>=!?,.:;";
+static const std::set<std::string> reserved = {
+  "var", "while", "if", "else", "break", "continue", "return", "fn", "typeof", "keys", "empty", "float64"
 };
-std::vector<std::string> multiCharSymbols = {
+static const std::vector<std::string> multiCharSymbols = {
   "&&=", "||=", "**=", "==", "!=", "<=", ">=", "&&", "||", "**", "+=", "-=", "*=", "/=", "%="
 };
 
+std::string sourceLocation(const std::string &file, std::uint32_t line, std::uint32_t column) {
+  return "\n  at " + file + ":" + std::to_string(line) + ":" + std::to_string(column);
+}
+
+std::string sourceLocation(const Token &token) {
+  return sourceLocation(token.file, token.line, token.column);
+}
+
 void parse(const char *source, std::vector<Token> &tokens, const char *filename) {
   std::uint32_t line = 1, column = 1;
   while (*source) {
@@ -41,8 +49,7 @@ void parse(const char *source, std::vector<Token> &tokens, const char *filename)
       column += 2;
       for (;;) {
         if (!*source) {
-          std::cout << "unterminated comment\n";
-          exit(1);
+          throw ScriptError("unterminated comment");
         }
         if (*source == '*' && source[1] == '/') {
           source += 2;
@@ -96,8 +103,7 @@ void parse(const char *source, std::vector<Token> &tokens, const char *filename)
       std::vector<char> chars;
       while (source[len] != '"') {
         if (!source[len] || source[len] == '\n') {
-          std::cout << "Unterminated string\n  at " << filename << ":" << line << ":" << column << "\n";
-          exit(1);
+          throw ScriptError("Unterminated string" + sourceLocation(filename, line, column));
         }
         if (source[len] != '\\') {
           chars.push_back(source[len]);
@@ -125,8 +131,7 @@ void parse(const char *source, std::vector<Token> &tokens, const char *filename)
             chars.push_back('"');
             break;
           default:
-            std::cout << "Invalid escape sequence\n  at " << filename << ":" << line << ":" << column << "\n";
-            exit(1);
+            throw ScriptError("Invalid escape sequence" + sourceLocation(filename, line, column));
         }
         len++;
       }
@@ -153,7 +158,7 @@ void parse(const char *source, std::vector<Token> &tokens, const char *filename)
     }
     for (auto &symbol : multiCharSymbols) {
       size_t len = symbol.size();
-      if (std::string(source, len) == symbol) {
+      if (!strncmp(source, symbol.c_str(), len)) {
         tokens.push_back(Token(symbol, line, column, TokenKind::SYMBOL, filename));
         column += len;
         source += len;
@@ -166,8 +171,7 @@ void parse(const char *source, std::vector<Token> &tokens, const char *filename)
       source++;
       continue;
     }
-    std::cerr << "Unexpected character\n  at " << filename << ":" << line << ":" << column << "\n";
-    exit(1);
+    throw ScriptError("Unexpected character" + sourceLocation(filename, line, column));
     continue_label:;
   }
 }
@@ -1,7 +1,15 @@
 #include "main.hpp"
 #include "abnode.hpp"
+#include "engine.hpp"
+#include "stats.hpp"
+#include "profile.hpp"
+#include "snapshot.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 
-std::vector<std::string> kinds = {
+const std::vector<std::string> kinds = {
   "RESERVED",
   "STRING",
   "NUMBER",
@@ -9,12 +17,110 @@ std::vector<std::string> kinds = {
   "SYMBOL"
 };
 
-int main() {
-  std::vector<Token> tokens;
-  parse("var a = { a: 0, b: 7 };", tokens, "unknown.ms");
-  for (auto &token : tokens)
-    std::cout << token.value << " (" << token.line << ":" << token.column << ") " << kinds[static_cast<int>(token.kind)] << "\n";
-  while (tokens.size()) parseStatement(tokens);
+int main(int argc, char **argv) {
+  ScriptStats stats;
+  bool collectStats = false, printTokens = false;
+  const char *profileOutput = nullptr, *snapshotOutput = nullptr, *snapshotInput = nullptr;
+  std::string filename = "unknown.ms";
+  std::string source = "var a = { a: 0, b: 7 };";
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--tokens")) {
+      printTokens = true;
+      continue;
+    }
+    if (!strcmp(argv[i], "--stats")) {
+      collectStats = true;
+      continue;
+    }
+    if (!strcmp(argv[i], "--stats-hw")) {
+      collectStats = stats.hardwareCounters = true;
+      continue;
+    }
+    if (!strcmp(argv[i], "--profile-parse") && i + 1 < argc) {
+      profileOutput = argv[++i];
+      continue;
+    }
+    if (!strcmp(argv[i], "--snapshot") && i + 1 < argc) {
+      snapshotOutput = argv[++i];
+      continue;
+    }
+    if (!strcmp(argv[i], "--load") && i + 1 < argc) {
+      snapshotInput = argv[++i];
+      continue;
+    }
+    std::ifstream file(argv[i], std::ios::binary);
+    if (!file) {
+      std::cerr << "Cannot open file: " << argv[i] << "\n";
+      return 1;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    source = buffer.str();
+    filename = argv[i];
+  }
+  ScriptStats *recorder = collectStats ? &stats : nullptr;
+  if (profileOutput && !startProfiler(1000)) {
+    std::cerr << "Cannot start profiler\n";
+    return 1;
+  }
+  if (printTokens) {
+    std::vector<Token> tokens;
+    try {
+      parse(source.c_str(), tokens, filename.c_str());
+    } catch (const ScriptError &error) {
+      std::cerr << error.what() << "\n";
+      return 1;
+    }
+    for (auto &token : tokens)
+      std::cout << token.value << " (" << token.line << ":" << token.column << ") " << kinds[static_cast<int>(token.kind)] << "\n";
+  }
+  CompileResult result;
+  if (snapshotInput) {
+    std::ifstream in(snapshotInput, std::ios::binary);
+    if (!in) {
+      std::cerr << "Cannot open file: " << snapshotInput << "\n";
+      return 1;
+    }
+    {
+      PhaseRecorder phase(recorder, "load");
+      result = readSnapshot(in);
+    }
+    if (recorder && result.script) {
+      in.clear();
+      stats.bytes = in.seekg(0, std::ios::end).tellg();
+      stats.describe(result.script->file, result.script->statements);
+    }
+  } else {
+    Engine engine;
+    result = engine.compile(source, filename, recorder);
+  }
+  if (!result.script) {
+    std::cerr << result.error << "\n";
+    return 1;
+  }
+  if (snapshotOutput) {
+    // Written beside the target and renamed over it only once complete, so a
+    // failed write never leaves a truncated snapshot at the target path.
+    std::string temporary = std::string(snapshotOutput) + ".tmp";
+    std::ofstream out(temporary, std::ios::binary);
+    std::string error = out ? writeSnapshot(*result.script, out) : "Cannot open file: " + temporary;
+    out.close();
+    if (error.empty() && !out) error = "Cannot write file: " + temporary;
+    if (error.empty() && std::rename(temporary.c_str(), snapshotOutput)) {
+      std::remove(snapshotOutput);
+      if (std::rename(temporary.c_str(), snapshotOutput)) error = "Cannot write file: " + std::string(snapshotOutput);
+    }
+    if (!error.empty()) {
+      std::remove(temporary.c_str());
+      std::cerr << error << "\n";
+      return 1;
+    }
+  }
+  if (profileOutput) {
+    std::ofstream out(profileOutput);
+    out << stopProfiler(filename + " (parse time)");
+  }
   std::cout << "end\n";
+  if (collectStats) std::cerr << stats.toJson() << "\n";
   return 0;
 }
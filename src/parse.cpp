@@ -1,142 +1,207 @@
 #include "main.hpp"
 #include "node.hpp"
+#include "profile.hpp"
 #include <string>
 
+static thread_local NodeArena *currentArena = nullptr;
+
+Node::Node() {
+  if (currentArena) currentArena->nodes.push_back(this);
+}
+
+NodeArena::~NodeArena() {
+  for (auto node : nodes) delete node;
+}
+
+ArenaScope::ArenaScope(NodeArena &arena) : previous(currentArena) {
+  currentArena = &arena;
+}
+
+ArenaScope::~ArenaScope() {
+  currentArena = previous;
+}
+
 void except(Token &token, const char *expected) {
   if (token.value == expected) return;
-  std::cerr << "Unexpected token: " << token.value << "\n  at " << token.file << ":" << token.line << ":" << token.column << "\n";
-  exit(1);
+  throw ScriptError("Unexpected token: " + token.value + sourceLocation(token));
 }
 
-ExpressionNode *parseExpression(std::vector<Token> &tokens);
+// Bounds the parser's recursion, so deeply nested source is reported as a
+// ScriptError instead of overflowing the stack.
+const int maxParseDepth = 512;
+
+struct NestingGuard {
+  TokenCursor &tokens;
+  NestingGuard(TokenCursor &tokens) : tokens(tokens) {
+    if (tokens.depth >= maxParseDepth) {
+      throw ScriptError("Error: Script is nested too deeply" + (tokens.size() ? sourceLocation(tokens[0]) : ""));
+    }
+    tokens.depth++;
+  }
+  ~NestingGuard() { tokens.depth--; }
+};
+
+ExpressionNode *parseExpression(TokenCursor &tokens);
 
-ExpressionNode *parseValueExpression(std::vector<Token> &tokens) {
+// Parses `[a, b, ...]` starting at the opening bracket. With `numeric`, an
+// element that is a string, object or array literal is rejected, since it
+// can never evaluate to a number.
+std::vector<ExpressionNode*> parseArrayElements(TokenCursor &tokens, bool numeric) {
+  tokens.next();
+  std::vector<ExpressionNode*> elements;
   if (!tokens.size()) {
-    std::cerr << "Error: Unexpected end of file\n";
-    exit(1);
+    throw ScriptError("Error: Unexpected end of file");
+  }
+  if (tokens[0].value != "]") for (;;) {
+    Token &start = tokens[0];
+    elements.push_back(parseExpression(tokens));
+    ExpressionNode *element = elements.back();
+    if (numeric && (dynamic_cast<StringNode*>(element) || dynamic_cast<ObjectLiteralNode*>(element) ||
+                    dynamic_cast<ArrayLiteralNode*>(element) || dynamic_cast<Float64ArrayNode*>(element))) {
+      throw ScriptError("Error: float64 array elements must be numbers" + sourceLocation(start));
+    }
+    if (!tokens.size()) {
+      throw ScriptError("Error: Unexpected end of file");
+    }
+    if (tokens[0].value == ",") {
+      tokens.next();
+      continue;
+    }
+    if (tokens[0].value == "]") break;
+    throw ScriptError("Error: Unexpected token: " + tokens[0].value + sourceLocation(tokens[0]));
+  }
+  tokens.next();
+  return elements;
+}
+
+ExpressionNode *parseValueExpression(TokenCursor &tokens) {
+  if (!tokens.size()) {
+    throw ScriptError("Error: Unexpected end of file");
   }
   if (tokens[0].value == "(") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     ExpressionNode *expr = parseExpression(tokens);
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], ")");
-    tokens.erase(tokens.begin());
+    tokens.next();
     return expr;
   }
   if (tokens[0].kind == TokenKind::NUMBER) {
-    NumberNode *node = new NumberNode(std::stod(tokens[0].value));
-    tokens.erase(tokens.begin());
+    double value;
+    try {
+      value = std::stod(tokens[0].value);
+    } catch (const std::out_of_range &) {
+      throw ScriptError("Error: Number out of range: " + tokens[0].value + sourceLocation(tokens[0]));
+    }
+    NumberNode *node = new NumberNode(value);
+    tokens.next();
     return node;
   }
   if (tokens[0].kind == TokenKind::STRING) {
     StringNode *node = new StringNode(tokens[0].value);
-    tokens.erase(tokens.begin());
+    tokens.next();
     return node;
   }
   if (tokens[0].kind == TokenKind::IDENTIFIER) {
     IdentifierNode *node = new IdentifierNode(tokens[0].value);
-    tokens.erase(tokens.begin());
+    tokens.next();
     return node;
   }
   if (tokens[0].value == "{") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     std::map<std::string, ExpressionNode*> members;
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     if (tokens[0].value != "}") for (;;) {
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       if (tokens[0].kind != TokenKind::IDENTIFIER && tokens[0].kind != TokenKind::STRING) {
-        std::cerr << "Error: Unexpected token: " << tokens[0].value << "\n  at " << tokens[0].file << ":" << tokens[0].line << ":" << tokens[0].column << "\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected token: " + tokens[0].value + sourceLocation(tokens[0]));
       }
       std::string key = tokens[0].value;
-      tokens.erase(tokens.begin());
+      tokens.next();
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       except(tokens[0], ":");
-      tokens.erase(tokens.begin());
+      tokens.next();
       members[key] = parseExpression(tokens);
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       if (tokens[0].value == ",") {
-        tokens.erase(tokens.begin());
+        tokens.next();
         continue;
       }
       if (tokens[0].value == "}") break;
-      std::cerr << "Error: Unexpected token: " << tokens[0].value << "\n  at " << tokens[0].file << ":" << tokens[0].line << ":" << tokens[0].column << "\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected token: " + tokens[0].value + sourceLocation(tokens[0]));
     }
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new ObjectLiteralNode(members);
   }
-  std::cerr << "Unexpected token: " << tokens[0].value << "\n  at " << tokens[0].file << ":" << tokens[0].line << ":" << tokens[0].column << "\n";
-  exit(1);
+  if (tokens[0].value == "float64") {
+    tokens.next();
+    if (!tokens.size()) {
+      throw ScriptError("Error: Unexpected end of file");
+    }
+    except(tokens[0], "[");
+    return new Float64ArrayNode(parseArrayElements(tokens, true));
+  }
+  if (tokens[0].value == "[") {
+    return new ArrayLiteralNode(parseArrayElements(tokens, false));
+  }
+  throw ScriptError("Unexpected token: " + tokens[0].value + sourceLocation(tokens[0]));
 }
 
-ExpressionNode *parsePrimaryExpression(std::vector<Token> &tokens) {
+ExpressionNode *parsePrimaryExpression(TokenCursor &tokens) {
   ExpressionNode *node = parseValueExpression(tokens);
   for (;;) {
     if (!tokens.size()) return node;
     std::string &val = tokens[0].value;
     if (val == ".") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       if (tokens[0].kind != TokenKind::IDENTIFIER) {
-        std::cerr << "Expected identifier after '.'\n  at " << tokens[0].file << ":" << tokens[0].line << ":" << tokens[0].column << "\n";
-        exit(1);
+        throw ScriptError("Expected identifier after '.'" + sourceLocation(tokens[0]));
       }
       node = new MemberAccessNode(node, new StringNode(tokens[0].value));
-      tokens.erase(tokens.begin());
+      tokens.next();
     } else if (val == "[") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new MemberAccessNode(node, parseExpression(tokens));
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       except(tokens[0], "]");
-      tokens.erase(tokens.begin());
+      tokens.next();
     } else if (val == "(") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       std::vector<ExpressionNode*> args;
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       if (tokens[0].value != ")") for (;;) {
         args.push_back(parseExpression(tokens));
         if (!tokens.size()) {
-          std::cerr << "Error: Unexpected end of file\n";
-          exit(1);
+          throw ScriptError("Error: Unexpected end of file");
         }
         if (tokens[0].value == ",") {
-          tokens.erase(tokens.begin());
+          tokens.next();
           continue;
         }
         if (tokens[0].value == ")") break;
-        std::cerr << "Error: Unexpected token: " << tokens[0].value << "\n  at " << tokens[0].file << ":" << tokens[0].line << ":" << tokens[0].column << "\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected token: " + tokens[0].value + sourceLocation(tokens[0]));
       }
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new FunctionCallNode(node, args);
     } else {
       return node;
@@ -144,50 +209,51 @@ ExpressionNode *parsePrimaryExpression(std::vector<Token> &tokens) {
   }
 }
 
-ExpressionNode *parseUnaryExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseUnaryExpression(TokenCursor &tokens) {
   if (tokens.size()) {
     if (tokens[0].value == "!") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       return new LogicalNotNode(parsePrimaryExpression(tokens));
     }
     if (tokens[0].value == "typeof") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       return new TypeofNode(parsePrimaryExpression(tokens));
     }
   }
   return parsePrimaryExpression(tokens);
 }
 
-ExpressionNode *parsePowExpression(std::vector<Token> &tokens) {
+ExpressionNode *parsePowExpression(TokenCursor &tokens) {
   ExpressionNode *left = parseUnaryExpression(tokens);
   if (tokens.size() && tokens[0].value == "**") {
-    tokens.erase(tokens.begin());
+    tokens.next();
+    NestingGuard guard(tokens);
     return new PowerNode(left, parsePowExpression(tokens));
   }
   return left;
 }
 
-ExpressionNode *parseUnaryMinusExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseUnaryMinusExpression(TokenCursor &tokens) {
   if (tokens.size() && tokens[0].value == "-") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new UnaryMinusNode(parsePowExpression(tokens));
   }
   return parsePowExpression(tokens);
 }
 
-ExpressionNode *parseMulDivExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseMulDivExpression(TokenCursor &tokens) {
   ExpressionNode *node = parseUnaryMinusExpression(tokens);
   for (;;) {
     if (!tokens.size()) return node;
     std::string &val = tokens[0].value;
     if (val == "*") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new MultiplicationNode(node, parseUnaryMinusExpression(tokens));
     } else if (val == "/") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new DivisionNode(node, parseUnaryMinusExpression(tokens));
     } else if (val == "%") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new RemainderNode(node, parseUnaryMinusExpression(tokens));
     } else {
       return node;
@@ -195,16 +261,16 @@ ExpressionNode *parseMulDivExpression(std::vector<Token> &tokens) {
   }
 }
 
-ExpressionNode *parseAddSubExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseAddSubExpression(TokenCursor &tokens) {
   ExpressionNode *node = parseMulDivExpression(tokens);
   for (;;) {
     if (!tokens.size()) return node;
     std::string &val = tokens[0].value;
     if (val == "+") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new AdditionNode(node, parseMulDivExpression(tokens));
     } else if (val == "-") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new SubtractionNode(node, parseMulDivExpression(tokens));
     } else {
       return node;
@@ -212,22 +278,22 @@ ExpressionNode *parseAddSubExpression(std::vector<Token> &tokens) {
   }
 }
 
-ExpressionNode *parseRelationalExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseRelationalExpression(TokenCursor &tokens) {
   ExpressionNode *node = parseAddSubExpression(tokens);
   for (;;) {
     if (!tokens.size()) return node;
     std::string &val = tokens[0].value;
     if (val == "<") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new LessThanNode(node, parseAddSubExpression(tokens));
     } else if (val == ">") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new GreaterThanNode(node, parseAddSubExpression(tokens));
     } else if (val == "<=") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new LessThanOrEqualNode(node, parseAddSubExpression(tokens));
     } else if (val == ">=") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new GreaterThanOrEqualNode(node, parseAddSubExpression(tokens));
     } else {
       return node;
@@ -235,16 +301,16 @@ ExpressionNode *parseRelationalExpression(std::vector<Token> &tokens) {
   }
 }
 
-ExpressionNode *parseEqualityExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseEqualityExpression(TokenCursor &tokens) {
   ExpressionNode *node = parseRelationalExpression(tokens);
   for (;;) {
     if (!tokens.size()) return node;
     std::string &val = tokens[0].value;
     if (val == "==") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new EqualityNode(node, parseRelationalExpression(tokens));
     } else if (val == "!=") {
-      tokens.erase(tokens.begin());
+      tokens.next();
       node = new InequalityNode(node, parseRelationalExpression(tokens));
     } else {
       return node;
@@ -252,238 +318,231 @@ ExpressionNode *parseEqualityExpression(std::vector<Token> &tokens) {
   }
 }
 
-ExpressionNode *parseLogicalAndExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseLogicalAndExpression(TokenCursor &tokens) {
   ExpressionNode *left = parseEqualityExpression(tokens);
   while (tokens.size() && tokens[0].value == "&&") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     ExpressionNode *right = parseEqualityExpression(tokens);
     left = new LogicalAndNode(left, right);
   }
   return left;
 }
 
-ExpressionNode *parseLogicalOrExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseLogicalOrExpression(TokenCursor &tokens) {
   ExpressionNode *left = parseLogicalAndExpression(tokens);
   while (tokens.size() && tokens[0].value == "||") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     ExpressionNode *right = parseLogicalAndExpression(tokens);
     left = new LogicalOrNode(left, right);
   }
   return left;
 }
 
-ExpressionNode *parseConditionalExpression(std::vector<Token> &tokens){
+ExpressionNode *parseConditionalExpression(TokenCursor &tokens){
   ExpressionNode *left = parseLogicalOrExpression(tokens);
   if (tokens.size() && tokens[0].value == "?") {
-    tokens.erase(tokens.begin());
+    tokens.next();
+    NestingGuard guard(tokens);
     ExpressionNode *middle = parseConditionalExpression(tokens);
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], ":");
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new ConditionalNode(left, middle, parseConditionalExpression(tokens));
   }
   return left;
 }
 
-ExpressionNode *parseAssignmentExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseAssignmentExpression(TokenCursor &tokens) {
+  NestingGuard guard(tokens);
   ExpressionNode *left = parseConditionalExpression(tokens);
   if (!tokens.size()) return left;
   if (tokens[0].value == "=") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new AssignmentNode(left, parseAssignmentExpression(tokens));
   }
   if (tokens[0].value == "+=") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new AssignmentNode(left, new AdditionNode(left, parseAssignmentExpression(tokens)));
   }
   if (tokens[0].value == "-=") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new AssignmentNode(left, new SubtractionNode(left, parseAssignmentExpression(tokens)));
   }
   if (tokens[0].value == "*=") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new AssignmentNode(left, new MultiplicationNode(left, parseAssignmentExpression(tokens)));
   }
   if (tokens[0].value == "/=") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new AssignmentNode(left, new DivisionNode(left, parseAssignmentExpression(tokens)));
   }
   if (tokens[0].value == "%=") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new AssignmentNode(left, new RemainderNode(left, parseAssignmentExpression(tokens)));
   }
   if (tokens[0].value == "&&=") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new LogicalAndNode(left, new AssignmentNode(left, parseAssignmentExpression(tokens)));
   }
   if (tokens[0].value == "||=") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new LogicalOrNode(left, new AssignmentNode(left, parseAssignmentExpression(tokens)));
   }
   return left;
 }
 
-ExpressionNode *parseExpression(std::vector<Token> &tokens) {
+ExpressionNode *parseExpression(TokenCursor &tokens) {
   return parseAssignmentExpression(tokens);
 }
 
-StatememtNode *parseStatement(std::vector<Token> &tokens) {
+StatememtNode *parseStatement(TokenCursor &tokens) {
+  NestingGuard guard(tokens);
+  if (!tokens.size()) {
+    throw ScriptError("Error: Unexpected end of file");
+  }
+  profileAt(tokens[0].line);
   if (tokens[0].value == "var") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     if (tokens[0].kind != TokenKind::IDENTIFIER) {
-      std::cerr << "Error: Expected identifier\n";
-      exit(1);
+      throw ScriptError("Error: Expected identifier");
     }
     std::string name = tokens[0].value;
-    tokens.erase(tokens.begin());
+    tokens.next();
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], "=");
-    tokens.erase(tokens.begin());
+    tokens.next();
     auto node = new VariableDeclarationNode(name, parseExpression(tokens));
+    if (!tokens.size()) {
+      throw ScriptError("Error: Unexpected end of file");
+    }
     except(tokens[0], ";");
-    tokens.erase(tokens.begin());
+    tokens.next();
     return node;
   }
   if (tokens[0].value == "while") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     ExpressionNode *condition = parseExpression(tokens);
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], ":");
-    tokens.erase(tokens.begin());
+    tokens.next();
     StatememtNode *body = parseStatement(tokens);
     return new WhileNode(condition, body);
   }
   if (tokens[0].value == "if") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     ExpressionNode *condition = parseExpression(tokens);
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], ":");
-    tokens.erase(tokens.begin());
+    tokens.next();
     StatememtNode *body = parseStatement(tokens);
     if (!tokens.size() || tokens[0].value != "else") return new IfNode(condition, body);
-    tokens.erase(tokens.begin());
+    tokens.next();
     StatememtNode *elseBody = parseStatement(tokens);
     return new IfNode(condition, body, elseBody);
   }
   if (tokens[0].value == "break") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], ";");
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new BreakNode();
   }
   if (tokens[0].value == "continue") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], ";");
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new ContinueNode();
   }
   if (tokens[0].value == "return") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     ExpressionNode *value = parseExpression(tokens);
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], ";");
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new ReturnNode(value);
   }
   if (tokens[0].value == "fn") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     if (tokens[0].kind != TokenKind::IDENTIFIER) {
-      std::cerr << "Error: Expected identifier\n";
-      exit(1);
+      throw ScriptError("Error: Expected identifier");
     }
     std::string name = tokens[0].value;
-    tokens.erase(tokens.begin());
+    tokens.next();
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     except(tokens[0], "(");
-    tokens.erase(tokens.begin());
+    tokens.next();
     std::vector<std::string> parameters;
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     if (tokens[0].value != ")") for (;;) {
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       if (tokens[0].kind != TokenKind::IDENTIFIER) {
-        std::cerr << "Error: Expected identifier\n";
-        exit(1);
+        throw ScriptError("Error: Expected identifier");
       }
       parameters.push_back(tokens[0].value);
-      tokens.erase(tokens.begin());
+      tokens.next();
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
       if (tokens[0].value == ",") {
-        tokens.erase(tokens.begin());
+        tokens.next();
         continue;
       }
       if (tokens[0].value == ")") break;
-      std::cerr << "Error: Unexpected token: " << tokens[0].value << "\n  at " << tokens[0].file << ":" << tokens[0].line << ":" << tokens[0].column << "\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected token: " + tokens[0].value + sourceLocation(tokens[0]));
     }
-    tokens.erase(tokens.begin());
-    return new FunctionDeclarationNode(name, parameters, parseStatement(tokens));
+    tokens.next();
+    auto node = new FunctionDeclarationNode(name, parameters, nullptr);
+    ProfileFrame frame(node->name.c_str());
+    node->body = parseStatement(tokens);
+    return node;
   }
   if (tokens[0].value == "{") {
-    tokens.erase(tokens.begin());
+    tokens.next();
     std::vector<StatememtNode*> statements;
     if (!tokens.size()) {
-      std::cerr << "Error: Unexpected end of file\n";
-      exit(1);
+      throw ScriptError("Error: Unexpected end of file");
     }
     while (tokens[0].value != "}") {
       statements.push_back(parseStatement(tokens));
       if (!tokens.size()) {
-        std::cerr << "Error: Unexpected end of file\n";
-        exit(1);
+        throw ScriptError("Error: Unexpected end of file");
       }
     }
-    tokens.erase(tokens.begin());
+    tokens.next();
     return new BlockNode(statements);
   }
   ExpressionNode* expr = parseExpression(tokens);
   if (!tokens.size()) {
-    std::cerr << "Error: Unexpected end of file\n";
-    exit(1);
+    throw ScriptError("Error: Unexpected end of file");
   }
   except(tokens[0], ";");
-  tokens.erase(tokens.begin());
+  tokens.next();
   return new ExpressionStatementNode(expr);
 }
@@ -0,0 +1,109 @@
+#include "profile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+thread_local const char *profileFrames[maxProfileDepth];
+thread_local volatile std::sig_atomic_t profileDepth = 0;
+thread_local volatile std::sig_atomic_t profileLine = 0;
+
+// Frame names are offsets into `names`. The handler copies each name there
+// because the frames point into the script being parsed, which may be freed
+// before stopProfiler reads them.
+struct ProfileSample {
+  std::uint32_t frames[maxProfileDepth];
+  int depth;
+  std::uint32_t line;
+};
+
+// Samples and names are written into preallocated buffers so the handler
+// never allocates. A sample whose names do not fit gets a depth of -1.
+const int maxProfileSamples = 1 << 16;
+const std::size_t maxProfileNameBytes = 1 << 22;
+static ProfileSample *samples = nullptr;
+static char *names = nullptr;
+static std::atomic<int> sampleCount(0);
+static std::atomic<std::size_t> nameBytes(0);
+
+#ifndef _WIN32
+static void takeSample(int) {
+  int index = sampleCount.fetch_add(1);
+  if (index >= maxProfileSamples) return;
+  ProfileSample &sample = samples[index];
+  int depth = profileDepth < maxProfileDepth ? profileDepth : maxProfileDepth;
+  std::size_t length = 0;
+  for (int i = 0; i < depth; i++) length += strlen(profileFrames[i]) + 1;
+  std::size_t offset = nameBytes.fetch_add(length);
+  if (offset + length > maxProfileNameBytes) {
+    sample.depth = -1;
+    return;
+  }
+  for (int i = 0; i < depth; i++) {
+    sample.frames[i] = offset;
+    std::size_t size = strlen(profileFrames[i]) + 1;
+    memcpy(names + offset, profileFrames[i], size);
+    offset += size;
+  }
+  sample.depth = depth;
+  sample.line = depth ? profileLine : 0;
+}
+
+bool startProfiler(int hz) {
+  if (!samples) samples = new ProfileSample[maxProfileSamples];
+  if (!names) names = new char[maxProfileNameBytes];
+  sampleCount = 0;
+  nameBytes = 0;
+  struct sigaction action = {};
+  action.sa_handler = takeSample;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, nullptr)) return false;
+  struct itimerval timer = {};
+  timer.it_interval.tv_usec = 1000000 / hz;
+  timer.it_value = timer.it_interval;
+  return !setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+// Returns the samples in collapsed-stack format, which flamegraph.pl and
+// compatible tools read directly. Stacks look like
+// "root;parse;fn f (declaration);line N count", naming the declaration being
+// parsed rather than a running function. Samples that arrived after the
+// buffers filled are counted under "root;[dropped: sample buffer full]".
+std::string stopProfiler(const std::string &root) {
+  struct itimerval timer = {};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  signal(SIGPROF, SIG_IGN);
+  std::map<std::string, std::uint64_t> stacks;
+  int count = std::min(sampleCount.load(), maxProfileSamples);
+  std::uint64_t dropped = sampleCount.load() - count;
+  for (int i = 0; i < count; i++) {
+    if (samples[i].depth < 0) {
+      dropped++;
+      continue;
+    }
+    std::string stack = root;
+    for (int j = 0; j < samples[i].depth; j++) {
+      if (j) stack += std::string(";fn ") + (names + samples[i].frames[j]) + " (declaration)";
+      else stack += std::string(";") + (names + samples[i].frames[j]);
+    }
+    if (samples[i].line) stack += ";line " + std::to_string(samples[i].line);
+    stacks[stack]++;
+  }
+  if (dropped) stacks[root + ";[dropped: sample buffer full]"] = dropped;
+  std::string collapsed;
+  for (auto &stack : stacks) collapsed += stack.first + " " + std::to_string(stack.second) + "\n";
+  return collapsed;
+}
+#else
+bool startProfiler(int) {
+  return false;
+}
+
+std::string stopProfiler(const std::string &) {
+  return "";
+}
+#endif
@@ -0,0 +1,380 @@
+#include "snapshot.hpp"
+#include "node.hpp"
+#include <cstring>
+#include <typeindex>
+#include <unordered_map>
+
+static const char magic[8] = { 'M', 'S', 'S', 'N', 'A', 'P', 0, 1 };
+
+// Reading recurses once per tree level, so nesting is capped to keep a crafted
+// file from overflowing the stack. Writing enforces the same cap so every
+// snapshot that is written can be read back.
+const int maxSnapshotDepth = 4096;
+
+enum class SnapshotTag : std::uint8_t {
+  REFERENCE,
+  NONE,
+  ASSIGNMENT,
+  CONDITIONAL,
+  LOGICAL_OR,
+  LOGICAL_AND,
+  EQUALITY,
+  INEQUALITY,
+  LESS_THAN,
+  GREATER_THAN,
+  LESS_THAN_OR_EQUAL,
+  GREATER_THAN_OR_EQUAL,
+  ADDITION,
+  SUBTRACTION,
+  MULTIPLICATION,
+  DIVISION,
+  REMAINDER,
+  POWER,
+  UNARY_MINUS,
+  LOGICAL_NOT,
+  TYPEOF,
+  MEMBER_ACCESS,
+  FUNCTION_CALL,
+  IDENTIFIER,
+  STRING,
+  NUMBER,
+  OBJECT_LITERAL,
+  WHILE,
+  IF,
+  BREAK,
+  CONTINUE,
+  RETURN,
+  VARIABLE_DECLARATION,
+  FUNCTION_DECLARATION,
+  EXPRESSION_STATEMENT,
+  BLOCK,
+  ARRAY_LITERAL,
+  FLOAT64_ARRAY
+};
+
+static const std::unordered_map<std::type_index, SnapshotTag> tags = {
+  { typeid(AssignmentNode), SnapshotTag::ASSIGNMENT },
+  { typeid(ConditionalNode), SnapshotTag::CONDITIONAL },
+  { typeid(LogicalOrNode), SnapshotTag::LOGICAL_OR },
+  { typeid(LogicalAndNode), SnapshotTag::LOGICAL_AND },
+  { typeid(EqualityNode), SnapshotTag::EQUALITY },
+  { typeid(InequalityNode), SnapshotTag::INEQUALITY },
+  { typeid(LessThanNode), SnapshotTag::LESS_THAN },
+  { typeid(GreaterThanNode), SnapshotTag::GREATER_THAN },
+  { typeid(LessThanOrEqualNode), SnapshotTag::LESS_THAN_OR_EQUAL },
+  { typeid(GreaterThanOrEqualNode), SnapshotTag::GREATER_THAN_OR_EQUAL },
+  { typeid(AdditionNode), SnapshotTag::ADDITION },
+  { typeid(SubtractionNode), SnapshotTag::SUBTRACTION },
+  { typeid(MultiplicationNode), SnapshotTag::MULTIPLICATION },
+  { typeid(DivisionNode), SnapshotTag::DIVISION },
+  { typeid(RemainderNode), SnapshotTag::REMAINDER },
+  { typeid(PowerNode), SnapshotTag::POWER },
+  { typeid(UnaryMinusNode), SnapshotTag::UNARY_MINUS },
+  { typeid(LogicalNotNode), SnapshotTag::LOGICAL_NOT },
+  { typeid(TypeofNode), SnapshotTag::TYPEOF },
+  { typeid(MemberAccessNode), SnapshotTag::MEMBER_ACCESS },
+  { typeid(FunctionCallNode), SnapshotTag::FUNCTION_CALL },
+  { typeid(IdentifierNode), SnapshotTag::IDENTIFIER },
+  { typeid(StringNode), SnapshotTag::STRING },
+  { typeid(NumberNode), SnapshotTag::NUMBER },
+  { typeid(ObjectLiteralNode), SnapshotTag::OBJECT_LITERAL },
+  { typeid(WhileNode), SnapshotTag::WHILE },
+  { typeid(IfNode), SnapshotTag::IF },
+  { typeid(BreakNode), SnapshotTag::BREAK },
+  { typeid(ContinueNode), SnapshotTag::CONTINUE },
+  { typeid(ReturnNode), SnapshotTag::RETURN },
+  { typeid(VariableDeclarationNode), SnapshotTag::VARIABLE_DECLARATION },
+  { typeid(FunctionDeclarationNode), SnapshotTag::FUNCTION_DECLARATION },
+  { typeid(ExpressionStatementNode), SnapshotTag::EXPRESSION_STATEMENT },
+  { typeid(BlockNode), SnapshotTag::BLOCK },
+  { typeid(ArrayLiteralNode), SnapshotTag::ARRAY_LITERAL },
+  { typeid(Float64ArrayNode), SnapshotTag::FLOAT64_ARRAY }
+};
+
+// Nodes are numbered in the order they finish being written, which is also
+// the order the reader creates them in. A node reached a second time (the
+// target of a compound assignment is shared by both halves) is written as a
+// reference to its number.
+struct SnapshotWriter {
+  std::ostream &out;
+  std::unordered_map<const Node*, std::uint32_t> written;
+  int depth;
+
+  void writeTag(SnapshotTag tag) {
+    out.put(static_cast<char>(tag));
+  }
+
+  void writeCount(std::uint32_t value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void writeString(const std::string &value) {
+    writeCount(value.size());
+    out.write(value.data(), value.size());
+  }
+
+  void writeNode(const Node *node) {
+    if (!node) return writeTag(SnapshotTag::NONE);
+    auto seen = written.find(node);
+    if (seen != written.end()) {
+      writeTag(SnapshotTag::REFERENCE);
+      return writeCount(seen->second);
+    }
+    if (++depth > maxSnapshotDepth) throw ScriptError("Script is nested too deeply for a snapshot");
+    SnapshotTag tag = tags.at(typeid(*node));
+    writeTag(tag);
+    if (auto binary = dynamic_cast<const BinaryOperatorNode*>(node)) {
+      writeNode(binary->left);
+      writeNode(binary->right);
+    } else if (auto conditional = dynamic_cast<const ConditionalNode*>(node)) {
+      writeNode(conditional->condition);
+      writeNode(conditional->trueBranch);
+      writeNode(conditional->falseBranch);
+    } else if (auto unary = dynamic_cast<const UnaryMinusNode*>(node)) {
+      writeNode(unary->operand);
+    } else if (auto unary = dynamic_cast<const LogicalNotNode*>(node)) {
+      writeNode(unary->operand);
+    } else if (auto unary = dynamic_cast<const TypeofNode*>(node)) {
+      writeNode(unary->operand);
+    } else if (auto call = dynamic_cast<const FunctionCallNode*>(node)) {
+      writeNode(call->callee);
+      writeCount(call->args.size());
+      for (auto arg : call->args) writeNode(arg);
+    } else if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+      writeString(identifier->name);
+    } else if (auto string = dynamic_cast<const StringNode*>(node)) {
+      writeString(string->value);
+    } else if (auto number = dynamic_cast<const NumberNode*>(node)) {
+      out.write(reinterpret_cast<const char*>(&number->value), sizeof(number->value));
+    } else if (auto object = dynamic_cast<const ObjectLiteralNode*>(node)) {
+      writeCount(object->members.size());
+      for (auto &member : object->members) {
+        writeString(member.first);
+        writeNode(member.second);
+      }
+    } else if (auto array = dynamic_cast<const ArrayLiteralNode*>(node)) {
+      writeCount(array->elements.size());
+      for (auto element : array->elements) writeNode(element);
+    } else if (auto array = dynamic_cast<const Float64ArrayNode*>(node)) {
+      writeCount(array->elements.size());
+      for (auto element : array->elements) writeNode(element);
+    } else if (auto loop = dynamic_cast<const WhileNode*>(node)) {
+      writeNode(loop->condition);
+      writeNode(loop->body);
+    } else if (auto branch = dynamic_cast<const IfNode*>(node)) {
+      writeNode(branch->condition);
+      writeNode(branch->trueBranch);
+      writeNode(branch->falseBranch);
+    } else if (auto ret = dynamic_cast<const ReturnNode*>(node)) {
+      writeNode(ret->value);
+    } else if (auto decl = dynamic_cast<const VariableDeclarationNode*>(node)) {
+      writeString(decl->name);
+      writeNode(decl->value);
+    } else if (auto fn = dynamic_cast<const FunctionDeclarationNode*>(node)) {
+      writeString(fn->name);
+      writeCount(fn->args.size());
+      for (auto &arg : fn->args) writeString(arg);
+      writeNode(fn->body);
+    } else if (auto expr = dynamic_cast<const ExpressionStatementNode*>(node)) {
+      writeNode(expr->expression);
+    } else if (auto block = dynamic_cast<const BlockNode*>(node)) {
+      writeCount(block->statements.size());
+      for (auto statement : block->statements) writeNode(statement);
+    }
+    std::uint32_t index = written.size();
+    written[node] = index;
+    depth--;
+  }
+};
+
+std::string writeSnapshot(const Script &script, std::ostream &out) {
+  SnapshotWriter writer = { out, {}, 0 };
+  try {
+    out.write(magic, sizeof(magic));
+    writer.writeString(script.file);
+    writer.writeCount(script.statements.size());
+    for (auto statement : script.statements) writer.writeNode(statement);
+  } catch (const ScriptError &error) {
+    return error.what();
+  }
+  return "";
+}
+
+// Snapshot files are input like any other, so every count, tag, reference and
+// the nesting depth are checked, and a malformed file is reported as a
+// ScriptError.
+struct SnapshotReader {
+  std::istream &in;
+  std::vector<Node*> nodes;
+  int depth;
+
+  [[noreturn]] void invalid() {
+    throw ScriptError("Invalid snapshot");
+  }
+
+  SnapshotTag readTag() {
+    int tag = in.get();
+    if (tag == std::char_traits<char>::eof() || tag > static_cast<int>(SnapshotTag::FLOAT64_ARRAY)) invalid();
+    return static_cast<SnapshotTag>(tag);
+  }
+
+  std::uint32_t readCount() {
+    std::uint32_t value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) invalid();
+    return value;
+  }
+
+  std::string readString() {
+    std::uint32_t size = readCount();
+    std::string value;
+    while (value.size() < size) {
+      char buffer[4096];
+      std::size_t chunk = std::min<std::size_t>(sizeof(buffer), size - value.size());
+      if (!in.read(buffer, chunk)) invalid();
+      value.append(buffer, chunk);
+    }
+    return value;
+  }
+
+  template <class T>
+  T *readNode(bool optional = false) {
+    Node *node = readAnyNode();
+    if (!node && optional) return nullptr;
+    T *typed = dynamic_cast<T*>(node);
+    if (!typed) invalid();
+    return typed;
+  }
+
+  ExpressionNode *readExpression() {
+    return readNode<ExpressionNode>();
+  }
+
+  StatememtNode *readStatement() {
+    return readNode<StatememtNode>();
+  }
+
+  template <class T>
+  Node *readBinary() {
+    ExpressionNode *left = readExpression();
+    return new T(left, readExpression());
+  }
+
+  Node *readAnyNode() {
+    SnapshotTag tag = readTag();
+    if (tag == SnapshotTag::NONE) return nullptr;
+    if (tag == SnapshotTag::REFERENCE) {
+      std::uint32_t index = readCount();
+      if (index >= nodes.size()) invalid();
+      return nodes[index];
+    }
+    if (++depth > maxSnapshotDepth) invalid();
+    Node *node = readTagged(tag);
+    nodes.push_back(node);
+    depth--;
+    return node;
+  }
+
+  Node *readTagged(SnapshotTag tag) {
+    switch (tag) {
+      case SnapshotTag::ASSIGNMENT: return readBinary<AssignmentNode>();
+      case SnapshotTag::LOGICAL_OR: return readBinary<LogicalOrNode>();
+      case SnapshotTag::LOGICAL_AND: return readBinary<LogicalAndNode>();
+      case SnapshotTag::EQUALITY: return readBinary<EqualityNode>();
+      case SnapshotTag::INEQUALITY: return readBinary<InequalityNode>();
+      case SnapshotTag::LESS_THAN: return readBinary<LessThanNode>();
+      case SnapshotTag::GREATER_THAN: return readBinary<GreaterThanNode>();
+      case SnapshotTag::LESS_THAN_OR_EQUAL: return readBinary<LessThanOrEqualNode>();
+      case SnapshotTag::GREATER_THAN_OR_EQUAL: return readBinary<GreaterThanOrEqualNode>();
+      case SnapshotTag::ADDITION: return readBinary<AdditionNode>();
+      case SnapshotTag::SUBTRACTION: return readBinary<SubtractionNode>();
+      case SnapshotTag::MULTIPLICATION: return readBinary<MultiplicationNode>();
+      case SnapshotTag::DIVISION: return readBinary<DivisionNode>();
+      case SnapshotTag::REMAINDER: return readBinary<RemainderNode>();
+      case SnapshotTag::POWER: return readBinary<PowerNode>();
+      case SnapshotTag::MEMBER_ACCESS: return readBinary<MemberAccessNode>();
+      case SnapshotTag::CONDITIONAL: {
+        ExpressionNode *condition = readExpression();
+        ExpressionNode *trueBranch = readExpression();
+        return new ConditionalNode(condition, trueBranch, readExpression());
+      }
+      case SnapshotTag::UNARY_MINUS: return new UnaryMinusNode(readExpression());
+      case SnapshotTag::LOGICAL_NOT: return new LogicalNotNode(readExpression());
+      case SnapshotTag::TYPEOF: return new TypeofNode(readExpression());
+      case SnapshotTag::FUNCTION_CALL: {
+        ExpressionNode *callee = readExpression();
+        std::vector<ExpressionNode*> args;
+        for (std::uint32_t i = readCount(); i; i--) args.push_back(readExpression());
+        return new FunctionCallNode(callee, args);
+      }
+      case SnapshotTag::IDENTIFIER: return new IdentifierNode(readString());
+      case SnapshotTag::STRING: return new StringNode(readString());
+      case SnapshotTag::NUMBER: {
+        double value;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) invalid();
+        return new NumberNode(value);
+      }
+      case SnapshotTag::OBJECT_LITERAL: {
+        std::map<std::string, ExpressionNode*> members;
+        for (std::uint32_t i = readCount(); i; i--) {
+          std::string key = readString();
+          members[key] = readExpression();
+        }
+        return new ObjectLiteralNode(members);
+      }
+      case SnapshotTag::ARRAY_LITERAL: {
+        std::vector<ExpressionNode*> elements;
+        for (std::uint32_t i = readCount(); i; i--) elements.push_back(readExpression());
+        return new ArrayLiteralNode(elements);
+      }
+      case SnapshotTag::FLOAT64_ARRAY: {
+        std::vector<ExpressionNode*> elements;
+        for (std::uint32_t i = readCount(); i; i--) elements.push_back(readExpression());
+        return new Float64ArrayNode(elements);
+      }
+      case SnapshotTag::WHILE: {
+        ExpressionNode *condition = readExpression();
+        return new WhileNode(condition, readStatement());
+      }
+      case SnapshotTag::IF: {
+        ExpressionNode *condition = readExpression();
+        StatememtNode *trueBranch = readStatement();
+        return new IfNode(condition, trueBranch, readNode<StatememtNode>(true));
+      }
+      case SnapshotTag::BREAK: return new BreakNode();
+      case SnapshotTag::CONTINUE: return new ContinueNode();
+      case SnapshotTag::RETURN: return new ReturnNode(readExpression());
+      case SnapshotTag::VARIABLE_DECLARATION: {
+        std::string name = readString();
+        return new VariableDeclarationNode(name, readExpression());
+      }
+      case SnapshotTag::FUNCTION_DECLARATION: {
+        std::string name = readString();
+        std::vector<std::string> args;
+        for (std::uint32_t i = readCount(); i; i--) args.push_back(readString());
+        return new FunctionDeclarationNode(name, args, readStatement());
+      }
+      case SnapshotTag::EXPRESSION_STATEMENT: return new ExpressionStatementNode(readExpression());
+      case SnapshotTag::BLOCK: {
+        std::vector<StatememtNode*> statements;
+        for (std::uint32_t i = readCount(); i; i--) statements.push_back(readStatement());
+        return new BlockNode(statements);
+      }
+      default: invalid();
+    }
+  }
+};
+
+CompileResult readSnapshot(std::istream &in) {
+  auto script = std::make_shared<Script>();
+  SnapshotReader reader = { in, {}, 0 };
+  try {
+    char header[sizeof(magic)];
+    if (!in.read(header, sizeof(header)) || memcmp(header, magic, sizeof(magic))) reader.invalid();
+    script->file = reader.readString();
+    ArenaScope scope(script->arena);
+    for (std::uint32_t i = reader.readCount(); i; i--) script->statements.push_back(reader.readStatement());
+  } catch (const ScriptError &error) {
+    return { nullptr, error.what() };
+  }
+  return { script, "" };
+}
@@ -0,0 +1,193 @@
+#include "stats.hpp"
+#include "node.hpp"
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static thread_local std::uint64_t allocations = 0;
+static thread_local std::uint64_t allocated = 0;
+
+void recordAllocation(std::size_t size) {
+  allocations++;
+  allocated += size;
+}
+
+std::uint64_t allocationCount() {
+  return allocations;
+}
+
+std::uint64_t allocatedBytes() {
+  return allocated;
+}
+
+struct HardwareCounters {
+  std::vector<std::pair<const char*, int>> fds;
+};
+
+#ifdef __linux__
+static HardwareCounters *startHardwareCounters() {
+  static const std::pair<const char*, std::uint64_t> events[] = {
+    { "cycles", PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache_misses", PERF_COUNT_HW_CACHE_MISSES },
+    { "branch_misses", PERF_COUNT_HW_BRANCH_MISSES }
+  };
+  HardwareCounters *counters = new HardwareCounters();
+  for (auto &event : events) {
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event.second;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0) continue;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    counters->fds.push_back({ event.first, fd });
+  }
+  return counters;
+}
+
+static void stopHardwareCounters(HardwareCounters *counters, PhaseStats &phase) {
+  for (auto &fd : counters->fds) {
+    ioctl(fd.second, PERF_EVENT_IOC_DISABLE, 0);
+    std::uint64_t value;
+    if (read(fd.second, &value, sizeof(value)) == sizeof(value)) phase.counters[fd.first] = value;
+    close(fd.second);
+  }
+  delete counters;
+}
+#else
+static HardwareCounters *startHardwareCounters() {
+  return nullptr;
+}
+
+static void stopHardwareCounters(HardwareCounters *, PhaseStats &) {}
+#endif
+
+static double now() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PhaseRecorder::PhaseRecorder(ScriptStats *stats, const char *name) : stats(stats), hardware(nullptr) {
+  if (!stats) return;
+  phase.name = name;
+  if (stats->hardwareCounters) {
+    hardware = startHardwareCounters();
+    if (!hardware || hardware->fds.empty()) stats->hardwareCountersUnavailable = true;
+  }
+  phase.allocations = allocations;
+  phase.allocatedBytes = allocated;
+  start = now();
+}
+
+PhaseRecorder::~PhaseRecorder() {
+  if (!stats) return;
+  phase.seconds = now() - start;
+  phase.allocations = allocations - phase.allocations;
+  phase.allocatedBytes = allocated - phase.allocatedBytes;
+  if (hardware) stopHardwareCounters(hardware, phase);
+  stats->phases.push_back(phase);
+}
+
+static std::string escapeJson(const std::string &value) {
+  std::string escaped;
+  for (char c : value) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    if (static_cast<unsigned char>(c) < 0x20) {
+      char buffer[8];
+      snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+      escaped += buffer;
+      continue;
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+void ScriptStats::clear() {
+  bool hardware = hardwareCounters;
+  *this = ScriptStats();
+  hardwareCounters = hardware;
+}
+
+void ScriptStats::describe(const std::string &file, const std::vector<StatememtNode*> &statements) {
+  this->file = file;
+  this->statements = statements.size();
+  nodes = 0;
+  for (auto statement : statements) nodes += countNodes(statement);
+}
+
+std::string ScriptStats::toJson() const {
+  std::ostringstream out;
+  out << "{\"file\": \"" << escapeJson(file) << "\", \"bytes\": " << bytes << ", \"tokens\": " << tokens
+      << ", \"statements\": " << statements << ", \"nodes\": " << nodes;
+  if (hardwareCounters) out << ", \"hardware_counters\": \"" << (hardwareCountersUnavailable ? "unavailable" : "enabled") << "\"";
+  out << ", \"phases\": [";
+  for (std::size_t i = 0; i < phases.size(); i++) {
+    const PhaseStats &phase = phases[i];
+    out << (i ? ", " : "") << "{\"name\": \"" << phase.name << "\", \"seconds\": " << phase.seconds
+        << ", \"allocations\": " << phase.allocations << ", \"allocated_bytes\": " << phase.allocatedBytes;
+    for (auto &counter : phase.counters) out << ", \"" << counter.first << "\": " << counter.second;
+    out << "}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+std::uint64_t countNodes(ExpressionNode *node) {
+  if (!node) return 0;
+  if (auto binary = dynamic_cast<BinaryOperatorNode*>(node))
+    return 1 + countNodes(binary->left) + countNodes(binary->right);
+  if (auto conditional = dynamic_cast<ConditionalNode*>(node))
+    return 1 + countNodes(conditional->condition) + countNodes(conditional->trueBranch) + countNodes(conditional->falseBranch);
+  if (auto unary = dynamic_cast<UnaryMinusNode*>(node)) return 1 + countNodes(unary->operand);
+  if (auto unary = dynamic_cast<LogicalNotNode*>(node)) return 1 + countNodes(unary->operand);
+  if (auto unary = dynamic_cast<TypeofNode*>(node)) return 1 + countNodes(unary->operand);
+  if (auto call = dynamic_cast<FunctionCallNode*>(node)) {
+    std::uint64_t count = 1 + countNodes(call->callee);
+    for (auto arg : call->args) count += countNodes(arg);
+    return count;
+  }
+  if (auto array = dynamic_cast<ArrayLiteralNode*>(node)) {
+    std::uint64_t count = 1;
+    for (auto element : array->elements) count += countNodes(element);
+    return count;
+  }
+  if (auto array = dynamic_cast<Float64ArrayNode*>(node)) {
+    std::uint64_t count = 1;
+    for (auto element : array->elements) count += countNodes(element);
+    return count;
+  }
+  if (auto object = dynamic_cast<ObjectLiteralNode*>(node)) {
+    std::uint64_t count = 1;
+    for (auto &member : object->members) count += countNodes(member.second);
+    return count;
+  }
+  return 1;
+}
+
+std::uint64_t countNodes(StatememtNode *node) {
+  if (!node) return 0;
+  if (auto loop = dynamic_cast<WhileNode*>(node)) return 1 + countNodes(loop->condition) + countNodes(loop->body);
+  if (auto branch = dynamic_cast<IfNode*>(node))
+    return 1 + countNodes(branch->condition) + countNodes(branch->trueBranch) + countNodes(branch->falseBranch);
+  if (auto ret = dynamic_cast<ReturnNode*>(node)) return 1 + countNodes(ret->value);
+  if (auto decl = dynamic_cast<VariableDeclarationNode*>(node)) return 1 + countNodes(decl->value);
+  if (auto fn = dynamic_cast<FunctionDeclarationNode*>(node)) return 1 + countNodes(fn->body);
+  if (auto expr = dynamic_cast<ExpressionStatementNode*>(node)) return 1 + countNodes(expr->expression);
+  if (auto block = dynamic_cast<BlockNode*>(node)) {
+    std::uint64_t count = 1;
+    for (auto statement : block->statements) count += countNodes(statement);
+    return count;
+  }
+  return 1;
+}